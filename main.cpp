@@ -1,7 +1,10 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "utls.h"
 #include "winograde_c4.h"
+#include "winograde_fmr.h"
 
 /**
  * F(2x2, 3x3)
@@ -218,6 +221,20 @@ int main() {
   auto output = (float*)calloc(N * OC * OH * OW, sizeof(float));
   // Winograde(output, pad_input, weight, bias);
   WinogradeNHWC(output, pad_input, weight, bias);
+  // fp16 / bfp16 storage, error against the fp32 output
+  auto half_output           = (float*)calloc(N * OC * OH * OW, sizeof(float));
+  DataType storage_types[]   = {DATA_TYPE_HALF, DATA_TYPE_BFP16};
+  const char* storage_name[] = {"fp16", "bfp16"};
+  for (int i = 0; i < 2; ++i) {
+    ConvParam param = {N, IC, IH + 2 * pad, IW + 2 * pad, OC, 3, 3, storage_types[i]};
+    WinogradeNHWCFmr(half_output, pad_input, weight, bias, param);
+    float max_error = 0.0f;
+    for (int k = 0; k < N * OC * OH * OW; ++k) {
+      max_error = std::max(max_error, std::fabs(half_output[k] - output[k]));
+    }
+    std::cout << storage_name[i] << " storage max error: " << max_error << std::endl;
+  }
+  free(half_output);
   ConvertBetweenNHWCAndNCHW<float>(output, nullptr, N, OC, OH, OW, NHWC2NCHW);
   WriteOutput(output, N * OC * OH * OW);
   free(pad_input);
@@ -0,0 +1,477 @@
+// Tencent is pleased to support the open source community by making TNN available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+/**
+ * compare every conv path with a double direct conv over random shape, fail on accuracy or speed regression
+ *
+ *  --seed N            random seed
+ *  --cases N           random shape count of every kernel size
+ *  --fp32-error E      max error / max(1, max |oracle|) of fp32 storage, 1xk and kx1 kernel, scaled by ErrorScale
+ *  --fp16-error E      same for fp16 storage
+ *  --bfp16-error E     same for bfp16 storage
+ *  --accuracy 0|1      run the accuracy test
+ *  --time 0|1          run the speed test, only meaningful in an optimized build without sanitizer
+ *  --time-tolerance T  fail if the time ratio of a path is over T x kTimeBaseline, or fp16 / bfp16 over T x fp32
+ * */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "winograde_c4.h"
+#include "winograde_fmr.h"
+
+struct TestOption {
+  unsigned seed         = 2020;
+  int cases             = 3;
+  double max_error[3]   = {8e-6, 1.2e-2, 8e-2};
+  bool accuracy         = true;
+  bool time             = true;
+  double time_tolerance = 1.25;
+};
+
+static const char* kStorageName[] = {"fp32", "fp16", "bfp16"};
+static const int kKernelSize[][2] = {{3, 3}, {5, 5}, {1, 3}, {3, 1}, {1, 5}, {5, 1}, {1, 7}, {7, 1}};
+
+static int fail_count = 0;
+
+/**
+ * error of F(m, r) grows with the transform size, against 1xk and kx1:
+ *  3x3:    F(2x2, 3x3) about 1/10
+ *  5x5:    F(2x2, 5x5) about 3x
+ * the threshold keeps about 1.5x of the worst case of seed 1-500
+ * */
+static double ErrorScale(int KH, int KW) {
+  if (KH == 3 && KW == 3) {
+    return 0.25;
+  } else if (KH == 5 && KW == 5) {
+    return 3.0;
+  }
+  return 1.0;
+}
+
+/**
+ * oracle, stride = 1, input is already padded
+ *
+ * input:   {N, IH, IW, IC}
+ * weight:  {OC, IC, KH, KW}
+ * output:  {N, OH, OW, OC}
+ * */
+template <class T>
+static void DirectConv(T* output, const float* input, const float* weight, const float* bias, const ConvParam& p) {
+  int OH = p.IH - p.KH + 1;
+  int OW = p.IW - p.KW + 1;
+  for (int n = 0; n < p.N; ++n) {
+    for (int oh = 0; oh < OH; ++oh) {
+      for (int ow = 0; ow < OW; ++ow) {
+        for (int oc = 0; oc < p.OC; ++oc) {
+          T temp = bias[oc];
+          for (int kh = 0; kh < p.KH; ++kh) {
+            for (int kw = 0; kw < p.KW; ++kw) {
+              const float* src = input + ((n * p.IH + oh + kh) * p.IW + ow + kw) * p.IC;
+              const float* w   = weight + oc * p.IC * p.KH * p.KW + kh * p.KW + kw;
+              for (int ic = 0; ic < p.IC; ++ic) {
+                temp += (T)w[ic * p.KH * p.KW] * src[ic];
+              }
+            }
+          }
+          output[((n * OH + oh) * OW + ow) * p.OC + oc] = temp;
+        }
+      }
+    }
+  }
+}
+
+template <class T>
+static void DirectBackwardData(T* input_grad, const float* output_grad, const float* weight, const ConvParam& p) {
+  int OH = p.IH - p.KH + 1;
+  int OW = p.IW - p.KW + 1;
+  std::fill_n(input_grad, p.N * p.IH * p.IW * p.IC, (T)0);
+  for (int n = 0; n < p.N; ++n) {
+    for (int oh = 0; oh < OH; ++oh) {
+      for (int ow = 0; ow < OW; ++ow) {
+        for (int oc = 0; oc < p.OC; ++oc) {
+          T g = output_grad[((n * OH + oh) * OW + ow) * p.OC + oc];
+          for (int kh = 0; kh < p.KH; ++kh) {
+            for (int kw = 0; kw < p.KW; ++kw) {
+              T* dst         = input_grad + ((n * p.IH + oh + kh) * p.IW + ow + kw) * p.IC;
+              const float* w = weight + oc * p.IC * p.KH * p.KW + kh * p.KW + kw;
+              for (int ic = 0; ic < p.IC; ++ic) {
+                dst[ic] += g * w[ic * p.KH * p.KW];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <class T>
+static void DirectBackwardWeight(T* weight_grad, T* bias_grad, const float* output_grad, const float* input,
+                                 const ConvParam& p) {
+  int OH = p.IH - p.KH + 1;
+  int OW = p.IW - p.KW + 1;
+  std::fill_n(weight_grad, p.OC * p.IC * p.KH * p.KW, (T)0);
+  std::fill_n(bias_grad, p.OC, (T)0);
+  for (int n = 0; n < p.N; ++n) {
+    for (int oh = 0; oh < OH; ++oh) {
+      for (int ow = 0; ow < OW; ++ow) {
+        for (int oc = 0; oc < p.OC; ++oc) {
+          T g = output_grad[((n * OH + oh) * OW + ow) * p.OC + oc];
+          bias_grad[oc] += g;
+          for (int kh = 0; kh < p.KH; ++kh) {
+            for (int kw = 0; kw < p.KW; ++kw) {
+              const float* src = input + ((n * p.IH + oh + kh) * p.IW + ow + kw) * p.IC;
+              T* dst           = weight_grad + oc * p.IC * p.KH * p.KW + kh * p.KW + kw;
+              for (int ic = 0; ic < p.IC; ++ic) {
+                dst[ic * p.KH * p.KW] += g * src[ic];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+static void RandomFill(std::vector<float>& data, std::mt19937& engine) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (auto& v : data) {
+    v = dist(engine);
+  }
+}
+
+// about 1/3 of the [oc, ic] slices is pruned to zero
+static void RandomPrune(std::vector<float>& weight, int OC, int IC, int kernel, std::mt19937& engine) {
+  for (int i = 0; i < OC * IC; ++i) {
+    if (engine() % 3 == 0) {
+      std::fill_n(weight.begin() + i * kernel, kernel, 0.0f);
+    }
+  }
+}
+
+/**
+ * print max and mean error, fail if max error / max(1, max |oracle|) is over the threshold
+ * */
+static void CheckError(const std::string& name, const float* result, const double* oracle, int count,
+                       double threshold) {
+  double max_error = 0.0;
+  double sum_error = 0.0;
+  double max_ref   = 1.0;
+  bool is_finite   = true;
+  for (int i = 0; i < count; ++i) {
+    double error = std::fabs(result[i] - oracle[i]);
+    is_finite    = is_finite && std::isfinite(result[i]);
+    max_error    = std::max(max_error, error);
+    max_ref      = std::max(max_ref, std::fabs(oracle[i]));
+    sum_error += error;
+  }
+  double relative = max_error / max_ref;
+  bool pass       = is_finite && relative <= threshold;
+  printf("%-4s %-52s max %.3e mean %.3e relative %.3e\n", pass ? "OK" : "FAIL", name.c_str(), max_error,
+         count > 0 ? sum_error / count : 0.0, relative);
+  if (!pass) {
+    ++fail_count;
+  }
+}
+
+static std::string ParamName(const char* path, const ConvParam& p) {
+  char name[128];
+  snprintf(name, sizeof(name), "%s %s k%dx%d n%d ic%d oc%d %dx%d", path, kStorageName[p.storage_type], p.KH, p.KW,
+           p.N, p.IC, p.OC, p.IH, p.IW);
+  return name;
+}
+
+/**
+ * WinogradeNHWC only support {1, 16, 6, 6} --> {1, 16, 4, 4}, 3x3
+ * */
+static void TestWinogradeC4(const TestOption& option, std::mt19937& engine) {
+  ConvParam p = {1, 16, 6, 6, 16, 3, 3, DATA_TYPE_FLOAT};
+  for (int c = 0; c < option.cases; ++c) {
+    std::vector<float> input(p.N * p.IH * p.IW * p.IC), weight(p.OC * p.IC * 9), bias(p.OC);
+    std::vector<float> output(p.N * 4 * 4 * p.OC, 0.0f);
+    std::vector<double> oracle(output.size());
+    RandomFill(input, engine);
+    RandomFill(weight, engine);
+    RandomFill(bias, engine);
+    RandomPrune(weight, p.OC, p.IC, 9, engine);
+    WinogradeNHWC(output.data(), input.data(), weight.data(), bias.data());
+    DirectConv(oracle.data(), input.data(), weight.data(), bias.data(), p);
+    CheckError(ParamName("c4 forward", p), output.data(), oracle.data(), (int)output.size(), option.max_error[0] * ErrorScale(3, 3));
+  }
+}
+
+static void TestWinogradeFmr(const TestOption& option, std::mt19937& engine) {
+  for (auto& kernel : kKernelSize) {
+    for (int c = 0; c < option.cases; ++c) {
+      int KH      = kernel[0];
+      int KW      = kernel[1];
+      ConvParam p = {1 + (int)(engine() % 2),       1 + (int)(engine() % 24), KH + (int)(engine() % 12),
+                     KW + (int)(engine() % 12), 1 + (int)(engine() % 13), KH, KW, DATA_TYPE_FLOAT};
+      int OH      = p.IH - KH + 1;
+      int OW      = p.IW - KW + 1;
+      std::vector<float> input(p.N * p.IH * p.IW * p.IC), weight(p.OC * p.IC * KH * KW), bias(p.OC);
+      std::vector<float> output_grad(p.N * OH * OW * p.OC);
+      RandomFill(input, engine);
+      RandomFill(weight, engine);
+      RandomFill(bias, engine);
+      RandomFill(output_grad, engine);
+      RandomPrune(weight, p.OC, p.IC, KH * KW, engine);
+
+      std::vector<double> oracle(output_grad.size()), input_grad_oracle(input.size());
+      std::vector<double> weight_grad_oracle(weight.size()), bias_grad_oracle(p.OC);
+      DirectConv(oracle.data(), input.data(), weight.data(), bias.data(), p);
+      DirectBackwardData(input_grad_oracle.data(), output_grad.data(), weight.data(), p);
+      DirectBackwardWeight(weight_grad_oracle.data(), bias_grad_oracle.data(), output_grad.data(), input.data(), p);
+
+      for (int storage = DATA_TYPE_FLOAT; storage <= DATA_TYPE_BFP16; ++storage) {
+        p.storage_type = (DataType)storage;
+        std::vector<float> output(output_grad.size(), 0.0f), input_grad(input.size(), 0.0f);
+        std::vector<float> weight_grad(weight.size(), 0.0f), bias_grad(p.OC, 0.0f);
+        std::vector<char> cache(WinogradeInputCacheSize(p));
+        WinogradeNHWCFmr(output.data(), input.data(), weight.data(), bias.data(), p, cache.data());
+        WinogradeBackwardData(input_grad.data(), output_grad.data(), weight.data(), p);
+        WinogradeBackwardWeight(weight_grad.data(), bias_grad.data(), output_grad.data(), cache.data(), p);
+        double threshold = option.max_error[storage] * ErrorScale(KH, KW);
+        CheckError(ParamName("fmr forward", p), output.data(), oracle.data(), (int)output.size(), threshold);
+        CheckError(ParamName("fmr backward data", p), input_grad.data(), input_grad_oracle.data(),
+                   (int)input_grad.size(), threshold);
+        CheckError(ParamName("fmr backward weight", p), weight_grad.data(), weight_grad_oracle.data(),
+                   (int)weight_grad.size(), threshold);
+        CheckError(ParamName("fmr backward bias", p), bias_grad.data(), bias_grad_oracle.data(), p.OC,
+                   option.max_error[DATA_TYPE_FLOAT]);
+      }
+    }
+  }
+}
+
+static void TestWinograde1D(const TestOption& option, std::mt19937& engine) {
+  for (int K = 3; K <= 7; K += 2) {
+    for (int c = 0; c < option.cases; ++c) {
+      ConvParam p = {1 + (int)(engine() % 2), 1 + (int)(engine() % 24), 1,
+                     K + (int)(engine() % 24), 1 + (int)(engine() % 13), 1, K, DATA_TYPE_FLOAT};
+      std::vector<float> input(p.N * p.IW * p.IC), weight(p.OC * p.IC * K), bias(p.OC);
+      std::vector<float> output(p.N * (p.IW - K + 1) * p.OC, 0.0f);
+      std::vector<double> oracle(output.size());
+      RandomFill(input, engine);
+      RandomFill(weight, engine);
+      RandomFill(bias, engine);
+      Winograde1DNWC(output.data(), input.data(), weight.data(), bias.data(), p.N, p.IC, p.IW, p.OC, K);
+      DirectConv(oracle.data(), input.data(), weight.data(), bias.data(), p);
+      CheckError(ParamName("1d forward", p), output.data(), oracle.data(), (int)output.size(),
+                 option.max_error[DATA_TYPE_FLOAT]);
+    }
+  }
+}
+
+/**
+ * invalid shape must return false and keep the output
+ * */
+static void TestInvalidParam() {
+  ConvParam params[] = {{1, 4, 2, 8, 4, 3, 3, DATA_TYPE_FLOAT}, {1, 4, 8, 2, 4, 3, 3, DATA_TYPE_FLOAT},
+                        {0, 4, 8, 8, 4, 3, 3, DATA_TYPE_FLOAT}, {1, 0, 8, 8, 4, 3, 3, DATA_TYPE_FLOAT},
+                        {1, 4, 8, 8, 0, 3, 3, DATA_TYPE_FLOAT}, {1, 4, 8, 8, 4, 2, 2, DATA_TYPE_FLOAT}};
+  std::vector<float> data(4 * 8 * 8 * 4 * 9, 1.0f);
+  std::vector<float> output(data.size(), 0.0f);
+  for (auto& p : params) {
+    bool pass = !WinogradeNHWCFmr(output.data(), data.data(), data.data(), data.data(), p) &&
+                !WinogradeBackwardData(output.data(), data.data(), data.data(), p) &&
+                !WinogradeBackwardWeight(output.data(), nullptr, data.data(), data.data(), p) &&
+                WinogradeInputCacheSize(p) == 0;
+    pass      = pass && std::all_of(output.begin(), output.end(), [](float v) { return v == 0.0f; });
+    printf("%-4s %s\n", pass ? "OK" : "FAIL", ParamName("invalid", p).c_str());
+    if (!pass) {
+      ++fail_count;
+    }
+  }
+  bool pass = !Winograde1DNWC(output.data(), data.data(), data.data(), data.data(), 1, 4, 2, 4, 3);
+  printf("%-4s invalid 1d iw2 k3\n", pass ? "OK" : "FAIL");
+  if (!pass) {
+    ++fail_count;
+  }
+  ConvParam valid = {1, 4, 8, 8, 4, 3, 3, DATA_TYPE_FLOAT};
+  pass            = !WinogradeBackwardWeight(output.data(), nullptr, data.data(), nullptr, valid);
+  printf("%-4s %s\n", pass ? "OK" : "FAIL", ParamName("invalid null cache", valid).c_str());
+  if (!pass) {
+    ++fail_count;
+  }
+}
+
+static double TimeOf(const std::function<void()>& func) {
+  auto begin = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static double Median(std::vector<double> value) {
+  std::sort(value.begin(), value.end());
+  return value[value.size() / 2];
+}
+
+static const char* kPathName[] = {"time forward", "time backward data", "time backward weight"};
+
+/**
+ * max time ratio of 11 runs of WinogradeBench, -O2 -falign-functions=64 -falign-loops=64 without sanitizer,
+ * WINOGRADE_NATIVE_ARCH=OFF, prepacked weight, measure again and update when a path is changed on purpose
+ *
+ *      {kernel, path, storage}
+ *      path:       forward, backward data, backward weight
+ *      fp32:       winograde / float direct conv of the same path
+ *      fp16/bfp16: winograde of the storage / fp32 winograde of the same path
+ * */
+static const double kTimeBaseline[8][3][3] = {
+    {{0.48, 1.02, 1.02}, {0.57, 1.01, 0.99}, {0.39, 1.14, 1.15}},  // 3x3
+    {{0.40, 1.15, 1.15}, {0.47, 1.16, 1.21}, {0.33, 1.12, 1.10}},  // 5x5
+    {{0.56, 1.14, 1.16}, {0.52, 1.14, 1.16}, {0.49, 1.10, 1.12}},  // 1x3
+    {{0.51, 1.15, 1.23}, {0.52, 1.14, 1.15}, {0.46, 1.10, 1.15}},  // 3x1
+    {{0.49, 1.01, 1.01}, {0.49, 1.01, 1.01}, {0.39, 1.14, 1.14}},  // 1x5
+    {{0.46, 1.02, 1.04}, {0.59, 0.98, 1.02}, {0.36, 1.14, 1.11}},  // 5x1
+    {{0.67, 1.02, 1.04}, {0.72, 1.02, 1.04}, {0.50, 1.18, 1.14}},  // 1x7
+    {{0.62, 1.01, 1.03}, {0.70, 1.02, 1.02}, {0.48, 1.11, 1.14}},  // 7x1
+};
+
+/**
+ * fail if the time ratio of a path drift over time_tolerance x kTimeBaseline, or fp16 / bfp16 storage is slower than
+ * time_tolerance x fp32 winograde of the same path
+ * */
+static void TestPerformance(const TestOption& option, std::mt19937& engine) {
+  for (int kernel = 0; kernel < 8; ++kernel) {
+    int KH = kKernelSize[kernel][0];
+    int KW = kKernelSize[kernel][1];
+    ConvParam p = {1, 32, 24 + KH - 1, 24 + KW - 1, 32, KH, KW, DATA_TYPE_FLOAT};
+    std::vector<float> input(p.N * p.IH * p.IW * p.IC), weight(p.OC * p.IC * KH * KW), bias(p.OC);
+    std::vector<float> output(p.N * 24 * 24 * p.OC), output_grad(output.size());
+    std::vector<float> input_grad(input.size()), weight_grad(weight.size()), bias_grad(p.OC);
+    RandomFill(input, engine);
+    RandomFill(weight, engine);
+    RandomFill(bias, engine);
+    RandomFill(output_grad, engine);
+
+    // the weight is prepacked out of the timing, like a model weight
+    ConvParam storage_param[3] = {p, p, p};
+    WinogradeWeight packed[3], data_packed[3];
+    std::vector<char> cache[3];
+    for (int storage = DATA_TYPE_FLOAT; storage <= DATA_TYPE_BFP16; ++storage) {
+      storage_param[storage].storage_type = (DataType)storage;
+      WinogradePrepackWeight(&packed[storage], weight.data(), storage_param[storage]);
+      WinogradePrepackBackwardDataWeight(&data_packed[storage], weight.data(), storage_param[storage]);
+      cache[storage].resize(WinogradeInputCacheSize(storage_param[storage]));
+      WinogradeNHWCFmr(output.data(), input.data(), weight.data(), bias.data(), storage_param[storage],
+                       cache[storage].data());
+    }
+
+    // {path, direct / fp32 / fp16 / bfp16}
+    std::function<void()> func[3][4];
+    func[0][0] = [&]() { DirectConv(output.data(), input.data(), weight.data(), bias.data(), p); };
+    func[1][0] = [&]() { DirectBackwardData(input_grad.data(), output_grad.data(), weight.data(), p); };
+    func[2][0] = [&]() {
+      DirectBackwardWeight(weight_grad.data(), bias_grad.data(), output_grad.data(), input.data(), p);
+    };
+    for (int storage = DATA_TYPE_FLOAT; storage <= DATA_TYPE_BFP16; ++storage) {
+      ConvParam sp                       = storage_param[storage];
+      const WinogradeWeight* wino_weight = &packed[storage];
+      const WinogradeWeight* data_weight = &data_packed[storage];
+      const char* wino_cache             = cache[storage].data();
+      func[0][storage + 1]               = [&, sp, wino_weight]() {
+        WinogradeNHWCFmr(output.data(), input.data(), *wino_weight, bias.data(), sp);
+      };
+      func[1][storage + 1] = [&, sp, data_weight]() {
+        WinogradeBackwardData(input_grad.data(), output_grad.data(), *data_weight, sp);
+      };
+      func[2][storage + 1] = [&, sp, wino_cache]() {
+        WinogradeBackwardWeight(weight_grad.data(), bias_grad.data(), output_grad.data(), wino_cache, sp);
+      };
+    }
+
+    for (int path = 0; path < 3; ++path) {
+      // the runs of a path are back to back in every round, the ratio of a round is hit alike by the noise
+      // of the machine, the median of the rounds is kept
+      const int round_num = 15;
+      std::vector<double> time[4], ratio[4];
+      for (int round = 0; round < round_num; ++round) {
+        for (int i = 0; i < 4; ++i) {
+          time[i].push_back(TimeOf(func[path][i]));
+        }
+        for (int storage = DATA_TYPE_FLOAT; storage <= DATA_TYPE_BFP16; ++storage) {
+          ratio[storage].push_back(time[storage + 1][round] / time[storage == DATA_TYPE_FLOAT ? 0 : 1][round]);
+        }
+      }
+      for (int storage = DATA_TYPE_FLOAT; storage <= DATA_TYPE_BFP16; ++storage) {
+        p.storage_type       = (DataType)storage;
+        double storage_ratio = Median(ratio[storage]);
+        double baseline      = kTimeBaseline[kernel][path][storage];
+        bool pass            = storage_ratio <= baseline * option.time_tolerance;
+        if (storage != DATA_TYPE_FLOAT) {
+          pass = pass && storage_ratio <= option.time_tolerance;
+        }
+        printf("%-4s %-52s %.3f ms / %s %.3f ms ratio %.3f baseline %.3f\n", pass ? "OK" : "FAIL",
+               ParamName(kPathName[path], p).c_str(), Median(time[storage + 1]),
+               storage == DATA_TYPE_FLOAT ? "direct" : "fp32",
+               Median(time[storage == DATA_TYPE_FLOAT ? 0 : 1]), storage_ratio, baseline);
+        if (!pass) {
+          ++fail_count;
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  TestOption option;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    double value    = atof(argv[i + 1]);
+    if (key == "--seed") {
+      option.seed = (unsigned)value;
+    } else if (key == "--cases") {
+      option.cases = (int)value;
+    } else if (key == "--fp32-error") {
+      option.max_error[DATA_TYPE_FLOAT] = value;
+    } else if (key == "--fp16-error") {
+      option.max_error[DATA_TYPE_HALF] = value;
+    } else if (key == "--bfp16-error") {
+      option.max_error[DATA_TYPE_BFP16] = value;
+    } else if (key == "--accuracy") {
+      option.accuracy = value != 0.0;
+    } else if (key == "--time") {
+      option.time = value != 0.0;
+    } else if (key == "--time-tolerance") {
+      option.time_tolerance = value;
+    } else {
+      fprintf(stderr, "unknown option: %s\n", key.c_str());
+      return 2;
+    }
+  }
+  printf("seed %u, cases %d\n", option.seed, option.cases);
+  std::mt19937 engine(option.seed);
+  if (option.accuracy) {
+    TestWinogradeC4(option, engine);
+    TestWinogradeFmr(option, engine);
+    TestWinograde1D(option, engine);
+    TestInvalidParam();
+  }
+  if (option.time) {
+    TestPerformance(option, engine);
+  }
+  printf("%d failed\n", fail_count);
+  return fail_count == 0 ? 0 : 1;
+}
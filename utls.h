@@ -15,6 +15,9 @@
 #ifndef WINOGRADECONV_UTLS_H
 #define WINOGRADECONV_UTLS_H
 
+#include <cassert>
+#include <cstring>
+
 float* GetInput();
 
 float* GetWeight();
@@ -47,14 +47,21 @@ void weight_convert(float* dst, const float* src) {
   for (int oc = 0; oc < OC; ++oc) {
     // loop for IC_R16, meaning, pad IC to 16
     for (int ic = 0; ic < IC_R16; ++ic) {
+      // pad channel and pruned channel are all zero, skip the transform
+      bool is_zero = true;
       if (ic < IC) {
         // get weight kernel: {3, 3}
         for (int i = 0; i < KH; ++i) {
           for (int j = 0; j < KW; ++j) {
             int index = oc * IC * KH * KW + ic * KH * KW + i * KW + j;
             w[i][j]   = src[index];
+            is_zero   = is_zero && w[i][j] == 0.0f;
           }
         }
+      }
+      if (is_zero) {
+        std::fill_n(&win_w[0][0], 4 * 4, 0.0f);
+      } else {
         // Gxg
         for (int i = 0; i < 4; ++i) {
           for (int j = 0; j < 3; ++j) {
@@ -67,34 +74,67 @@ void weight_convert(float* dst, const float* src) {
             win_w[i][j] = mid[i][0] * GT[0][j] + mid[i][1] * GT[1][j] + mid[i][2] * GT[2][j];
           }
         }
-        // reformat weight
-        int ic_m16 = ic % 16;
-        int ic_d4  = ic / 16;
-        int oc_m4  = oc % 4;
-        int oc_d4  = oc / 4;
-        for (int i = 0; i < 4; ++i) {
-          for (int j = 0; j < 4; ++j) {
-            int index  = oc_d4 * 4 * IC_R16 * 4 * 4 + (i * 4 + j) * IC_R16 * 4 + ic_d4 * 4 * 16 + oc_m4 * 16 + ic_m16;
-            dst[index] = win_w[i][j];
-          }
-        }
-      } else {
-        // process ic >= IC, pad channel
-        int ic_m16 = ic % 16;
-        int ic_d4  = ic / 16;
-        int oc_m4  = oc % 4;
-        int oc_d4  = ic / 4;
-        for (int i = 0; i < 4; ++i) {
-          for (int j = 0; j < 4; ++j) {
-            int index  = oc_d4 * 4 * IC_R16 * 4 * 4 + (i * 4 + j) * IC_R16 * 4 + ic_d4 * 4 * 16 + oc_m4 * 16 + ic_m16;
-            dst[index] = 0;
-          }
+      }
+      // reformat weight
+      int ic_m16 = ic % 16;
+      int ic_d4  = ic / 16;
+      int oc_m4  = oc % 4;
+      int oc_d4  = oc / 4;
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          int index  = oc_d4 * 4 * IC_R16 * 4 * 4 + (i * 4 + j) * IC_R16 * 4 + ic_d4 * 4 * 16 + oc_m4 * 16 + ic_m16;
+          dst[index] = win_w[i][j];
         }
       }
     }
   }
 }
 
+/**
+ * dense weight from weight_convert --> WinoSparseWeight
+ *
+ * a [oc, ic] block is dropped only when all of its 16 transformed value are zero,
+ * so the padded IC channels are dropped too.
+ * */
+void weight_compress(WinoSparseWeight* dst, const float* src, int OC, int IC) {
+  int IC_R16 = ROUND_UP(IC, 16);
+  int OC_R4  = ROUND_UP(OC, 4);
+  dst->oc_offset.assign(OC_R4 + 1, 0);
+  dst->ic_index.clear();
+  for (int oc = 0; oc < OC_R4; ++oc) {
+    int oc_m4 = oc % 4;
+    int oc_d4 = oc / 4;
+    for (int ic = 0; ic < IC_R16 && oc < OC; ++ic) {
+      int ic_m16   = ic % 16;
+      int ic_d4    = ic / 16;
+      bool is_zero = true;
+      for (int k = 0; k < 16 && is_zero; ++k) {
+        int index = oc_d4 * 4 * IC_R16 * 4 * 4 + k * IC_R16 * 4 + ic_d4 * 4 * 16 + oc_m4 * 16 + ic_m16;
+        is_zero   = src[index] == 0.0f;
+      }
+      if (!is_zero) {
+        dst->ic_index.push_back(ic);
+      }
+    }
+    dst->oc_offset[oc + 1] = (int)dst->ic_index.size();
+  }
+  dst->value.assign(dst->ic_index.size() * 16, 0.0f);
+  for (int oc = 0; oc < OC; ++oc) {
+    int oc_m4       = oc % 4;
+    int oc_d4       = oc / 4;
+    int block_begin = dst->oc_offset[oc_d4 * 4];
+    int block_nnz   = dst->oc_offset[oc_d4 * 4 + 4] - block_begin;
+    for (int idx = dst->oc_offset[oc]; idx < dst->oc_offset[oc + 1]; ++idx) {
+      int ic_m16 = dst->ic_index[idx] % 16;
+      int ic_d4  = dst->ic_index[idx] / 16;
+      for (int k = 0; k < 16; ++k) {
+        int index = oc_d4 * 4 * IC_R16 * 4 * 4 + k * IC_R16 * 4 + ic_d4 * 4 * 16 + oc_m4 * 16 + ic_m16;
+        dst->value[block_begin * 16 + k * block_nnz + idx - block_begin] = src[index];
+      }
+    }
+  }
+}
+
 void input_convert(float* wino_input_tile, const float* src_tile, const int width, const int IC) {
   int ic_r16                 = ROUND_UP(IC, 16);
   int w_step                 = 4 * ic_r16;
@@ -152,9 +192,14 @@ void input_convert(float* wino_input_tile, const float* src_tile, const int widt
 }
 
 /**
- * Hadamard product
+ * Hadamard product, only the nonzero [oc, ic] block of WinoSparseWeight
+ *
+ * wino_weight: nnz of the 4 oc, for one [4, 4] position
+ * ic_index:    ic of every nonzero block of the 4 oc
+ * oc_offset:   {5}, nonzero range of every oc, begin with 0
  * */
-void HadamardProduct(float* hadamard, const float* wino_input, const float* wino_weight, const int IC) {
+void HadamardProductSparse(float* hadamard, const float* wino_input, const float* wino_weight, const int* ic_index,
+                           const int* oc_offset, const int IC) {
   /**
    *  temp: (2, 2, 4)
    *         |  |  |
@@ -163,11 +208,10 @@ void HadamardProduct(float* hadamard, const float* wino_input, const float* wino
   float temp[2][2][4] = {0.0f};
   for (int i = 0; i < 2; ++i) {
     for (int j = 0; j < 2; ++j) {
+      const float* v = wino_input + i * 2 * IC + j * IC;
       for (int oc = 0; oc < 4; ++oc) {
-        for (int ic = 0; ic < IC; ++ic) {
-          auto w = wino_weight[oc * IC + ic];
-          auto v = wino_input[i * 2 * IC + j * IC + ic];
-          temp[i][j][oc] +=  w * v;
+        for (int k = oc_offset[oc]; k < oc_offset[oc + 1]; ++k) {
+          temp[i][j][oc] += wino_weight[k] * v[ic_index[k]];
         }
       }
     }
@@ -198,8 +242,7 @@ void dst_convert(float* output, const float* src, int h_stride, int w_stride, in
     for (int w = 0; w < 4; ++w) {
       for (int c = 0; c < 4; ++c) {
         /**
-         * wino format: 对吗?
-         * wino_src format: (4,4)x(2,2)x4
+         * wino_src format: (4,4)x(2,2)x4, checked by test/winograde_test.cpp
          *                              |
          *                              oc
          * */
@@ -302,6 +345,10 @@ void WinogradeNHWC(float* output, const float* input, const float* weight, const
   auto hadamard_buffer = (float*)calloc(hw_tile_size * hw_tile_size * 4, sizeof(float));
 
   weight_convert(wino_weight_buffer, weight);
+  // pruned [oc, ic] block and padded IC channel are skipped in the hadamard product
+  WinoSparseWeight sparse_weight;
+  weight_compress(&sparse_weight, wino_weight_buffer, OC, IC);
+  free(wino_weight_buffer);
   for (int oh = 0; oh < OH; oh += 4) {    // process 2 tile for OH
     for (int ow = 0; ow < OW; ow += 4) {  // process 2 tile for O
       for (int ht = 0; ht < 2; ++ht) {
@@ -318,12 +365,18 @@ void WinogradeNHWC(float* output, const float* input, const float* weight, const
         /**
          * Hadamard product
          * */
+        int block_begin = sparse_weight.oc_offset[oc];
+        int block_nnz   = sparse_weight.oc_offset[oc + 4] - block_begin;
+        int oc_offset[5];
+        for (int k = 0; k < 5; ++k) {
+          oc_offset[k] = sparse_weight.oc_offset[oc + k] - block_begin;
+        }
+        const int* ic_index = sparse_weight.ic_index.data() + block_begin;
         for (int win_tile = 0; win_tile < 16; ++win_tile) {
-          auto wino_input_tile = wino_input_buffer + win_tile * (2 * 2) * IC_R16;
-          // error: missing wintile
-          auto wino_weight_tile =wino_weight_buffer + win_tile * 4 * IC_R16 + oc * 16* IC_R16;
+          auto wino_input_tile      = wino_input_buffer + win_tile * (2 * 2) * IC_R16;
+          auto wino_weight_tile     = sparse_weight.value.data() + block_begin * 16 + win_tile * block_nnz;
           auto hadamard_buffer_tile = hadamard_buffer + win_tile * 16;
-          HadamardProduct(hadamard_buffer_tile, wino_input_tile, wino_weight_tile, IC_R16);
+          HadamardProductSparse(hadamard_buffer_tile, wino_input_tile, wino_weight_tile, ic_index, oc_offset, IC_R16);
         }
         for (int ht = 0; ht < 2; ++ht) {
           for (int wt = 0; wt < 2; ++wt) {
@@ -351,7 +404,6 @@ void WinogradeNHWC(float* output, const float* input, const float* weight, const
       }
     }
   }
-  free(wino_weight_buffer);
   free(wino_input_buffer);
   free(hadamard_buffer);
 }
@@ -15,6 +15,8 @@
 #ifndef WINOGRADECONV_WINOGRADEC4_H
 #define WINOGRADECONV_WINOGRADEC4_H
 
+#include <vector>
+
 #ifndef UP_DIV
 #define UP_DIV(x, y) (((int)(x) + (int)(y) - (1)) / (int)(y))
 #endif
@@ -22,6 +24,31 @@
 #define ROUND_UP(x, y) (((int)(x) + (int)(y) - (1)) / (int)(y) * (int)(y))
 #endif
 
+/**
+ * block sparse winograde weight, skip the [oc, ic] slices whose 4x4 transformed block is all zero
+ *
+ * oc_offset: {R(OC, 4) + 1}, nonzero ic range of every oc, like CSR row pointer
+ * ic_index:  {nnz}, ic of every nonzero block
+ * value:
+ *      size:   {16, nnz}
+ *      format: {R(OC,4)/4, [4, 4], nnz of the 4 oc}
+ *                           |   |
+ *                          KH  KW
+ * F(m, r) of winograde_fmr use the same layout, with [NH, NW] in place of [4, 4], and value in the storage type
+ * */
+template <class S>
+struct WinoSparseWeightT {
+  std::vector<int> oc_offset;
+  std::vector<int> ic_index;
+  std::vector<S> value;
+};
+
+typedef WinoSparseWeightT<float> WinoSparseWeight;
+
+void weight_convert(float* dst, const float* src);
+
+void weight_compress(WinoSparseWeight* dst, const float* src, int OC, int IC);
+
 void WinogradeNHWC(float* output, const float* input, const float* weight, const float* bias);
 
 #endif  // WINOGRADECONV_WINOGRADEC4_H
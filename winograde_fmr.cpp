@@ -0,0 +1,786 @@
+// Tencent is pleased to support the open source community by making TNN available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "winograde_fmr.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+static const double kPoints[] = {0.0, 1.0, -1.0, 2.0, -2.0, 0.5, -0.5, 3.0, -3.0, 1.0 / 3, -1.0 / 3};
+
+/**
+ * linear convolution c = g * x, x = (m), g = (r), c = (n)
+ *      c   = V^-1[(V_r g) hadamard (V_m x)]
+ * correlation is the transpose of it:
+ *      y   = V_m^T[(V_r g) hadamard (V^-T d)]
+ *      A^T = V_m^T, G = V_r, B^T = V^-T
+ * V, V_r, V_m is the vandermonde matrix of the points, the row of infinity only keep the highest term.
+ * f_j = prod(a_j - a_k) is moved from B^T to G, so B^T is the coefficient of prod(x - a_k), k != j.
+ * */
+void CookToom(int m, int r, float* AT, float* G, float* BT) {
+  int n = m + r - 1;
+  assert(n - 1 <= (int)(sizeof(kPoints) / sizeof(kPoints[0])));
+  std::vector<double> V(n * n, 0.0);
+  std::vector<double> inv(n * n, 0.0);
+  for (int j = 0; j < n - 1; ++j) {
+    for (int k = 0; k < n; ++k) {
+      V[j * n + k] = std::pow(kPoints[j], k);
+    }
+  }
+  V[(n - 1) * n + n - 1] = 1.0;
+  for (int i = 0; i < n; ++i) {
+    inv[i * n + i] = 1.0;
+  }
+  // gauss-jordan, V --> I, I --> V^-1
+  for (int col = 0; col < n; ++col) {
+    int pivot = col;
+    for (int i = col + 1; i < n; ++i) {
+      if (std::fabs(V[i * n + col]) > std::fabs(V[pivot * n + col])) {
+        pivot = i;
+      }
+    }
+    for (int k = 0; k < n; ++k) {
+      std::swap(V[col * n + k], V[pivot * n + k]);
+      std::swap(inv[col * n + k], inv[pivot * n + k]);
+    }
+    double scale = 1.0 / V[col * n + col];
+    for (int k = 0; k < n; ++k) {
+      V[col * n + k] *= scale;
+      inv[col * n + k] *= scale;
+    }
+    for (int i = 0; i < n; ++i) {
+      double factor = V[i * n + col];
+      if (i == col || factor == 0.0) {
+        continue;
+      }
+      for (int k = 0; k < n; ++k) {
+        V[i * n + k] -= factor * V[col * n + k];
+        inv[i * n + k] -= factor * inv[col * n + k];
+      }
+    }
+  }
+  for (int j = 0; j < n; ++j) {
+    bool infinity = j == n - 1;
+    double f      = 1.0;
+    for (int k = 0; k < n - 1 && !infinity; ++k) {
+      if (k != j) {
+        f *= kPoints[j] - kPoints[k];
+      }
+    }
+    for (int i = 0; i < m; ++i) {
+      AT[i * n + j] = (float)(infinity ? (i == m - 1) : std::pow(kPoints[j], i));
+    }
+    for (int k = 0; k < r; ++k) {
+      G[j * r + k] = (float)((infinity ? (k == r - 1) : std::pow(kPoints[j], k)) / f);
+    }
+    for (int k = 0; k < n; ++k) {
+      BT[j * n + k] = (float)(inv[k * n + j] * f);
+    }
+  }
+}
+
+/**
+ * row of input_convert, fp32 storage is written in place, other type is built in scratch and converted
+ * */
+static float* RowBuffer(float* dst, float* scratch) {
+  (void)scratch;
+  return dst;
+}
+
+template <class S>
+static float* RowBuffer(S* dst, float* scratch) {
+  (void)dst;
+  return scratch;
+}
+
+static void StoreRow(float* dst, const float* row, int count) {
+  (void)dst;
+  (void)row;
+  (void)count;
+}
+
+template <class S>
+static void StoreRow(S* dst, const float* row, int count) {
+  ConvertFromFloat(dst, row, count);
+}
+
+// tile count of one hadamard product, the transformed weight is reused by these tiles
+static const int kTileBlock = 8;
+
+/**
+ * F(MH x MW, RH x RW)
+ *
+ * S is the storage type of the transformed weight and the input tile buffer: float, fp16_t or bfp16_t.
+ * the input tile buffer is converted to fp32 once for every tile block, the weight row by row in the hadamard product.
+ *
+ * transformed weight: WinoSparseWeight, T = NH x NW
+ *      value:  {R(OC,4)/4, [NH, NW], nnz of the 4 oc}
+ * input tile buffer:
+ *      size:   (NHxNW)xkTileBlockxIC
+ *      format: {[NH, NW], kTileBlock, IC}
+ * hadamard buffer:
+ *      size:   kTileBlockx(NHxNW)x4
+ *      format: {kTileBlock, [NH, NW], 4}
+ *                                     |
+ *                                     OC
+ * */
+template <int MH, int RH, int MW, int RW, class S>
+struct WinogradeFmr {
+  typedef S storage_t;
+  static const int NH = MH + RH - 1;
+  static const int NW = MW + RW - 1;
+  static const int T  = NH * NW;
+
+  /**
+   * U = G_h x g x G_w^T
+   * g: (RH, RW), U: (NH, NW)
+   * */
+  static void weight_transform(float* dst, const float* src) {
+    const WinogradeTransform<MH, RH>& th = WinogradeTransform<MH, RH>::Get();
+    const WinogradeTransform<MW, RW>& tw = WinogradeTransform<MW, RW>::Get();
+    float mid[NH][RW] = {{0.0f}};
+    for (int i = 0; i < NH; ++i) {
+      for (int j = 0; j < RW; ++j) {
+        for (int k = 0; k < RH; ++k) {
+          mid[i][j] += th.G[i][k] * src[k * RW + j];
+        }
+      }
+    }
+    for (int i = 0; i < NH; ++i) {
+      for (int j = 0; j < NW; ++j) {
+        float temp = 0.0f;
+        for (int k = 0; k < RW; ++k) {
+          temp += mid[i][k] * tw.G[j][k];
+        }
+        dst[i * NW + j] = temp;
+      }
+    }
+  }
+
+  /**
+   * first pass counts the nonzero [oc, ic] of every oc, second pass transforms the kernels of every 4 oc into a
+   * block buffer and converts it to the storage type. G_h and G_w have full column rank, U is zero only if g is zero.
+   * */
+  static void weight_convert(WinoSparseWeightT<S>* dst, const float* src, int OC, int IC) {
+    int OC_R4 = ROUND_UP(OC, 4);
+    dst->oc_offset.assign(OC_R4 + 1, 0);
+    dst->ic_index.clear();
+    for (int oc = 0; oc < OC_R4; ++oc) {
+      for (int ic = 0; ic < IC && oc < OC; ++ic) {
+        const float* kernel = src + (oc * IC + ic) * RH * RW;
+        // pruned channel is all zero, skip it
+        if (std::any_of(kernel, kernel + RH * RW, [](float v) { return v != 0.0f; })) {
+          dst->ic_index.push_back(ic);
+        }
+      }
+      dst->oc_offset[oc + 1] = (int)dst->ic_index.size();
+    }
+    dst->value.resize(dst->ic_index.size() * T);
+    // {[NH, NW], nnz of the 4 oc}
+    std::vector<float> block;
+    for (int oc_begin = 0; oc_begin < OC; oc_begin += 4) {
+      int block_begin = dst->oc_offset[oc_begin];
+      int block_nnz   = dst->oc_offset[oc_begin + 4] - block_begin;
+      block.resize(T * block_nnz);
+      for (int oc = oc_begin; oc < std::min(oc_begin + 4, OC); ++oc) {
+        for (int idx = dst->oc_offset[oc]; idx < dst->oc_offset[oc + 1]; ++idx) {
+          float win_w[T];
+          weight_transform(win_w, src + (oc * IC + dst->ic_index[idx]) * RH * RW);
+          for (int k = 0; k < T; ++k) {
+            block[k * block_nnz + idx - block_begin] = win_w[k];
+          }
+        }
+      }
+      ConvertFromFloat(dst->value.data() + block_begin * T, block.data(), T * block_nnz);
+    }
+  }
+
+  /**
+   * V = B_h^T x d x B_w
+   * src:     {h_cnt, w_cnt, IC} of the input, out of range is zero
+   * dst:     {[NH, NW], IC}, the step of [NH, NW] is dst_step
+   * scratch: (2 x T + 1) x IC
+   * */
+  static void input_convert(S* dst, int dst_step, const float* src, int IW, int IC, int h_cnt, int w_cnt,
+                            float* scratch) {
+    const WinogradeTransform<MH, RH>& th = WinogradeTransform<MH, RH>::Get();
+    const WinogradeTransform<MW, RW>& tw = WinogradeTransform<MW, RW>::Get();
+    float* d   = scratch;
+    float* mid = scratch + T * IC;
+    std::fill_n(d, T * IC, 0.0f);
+    for (int h = 0; h < std::min(h_cnt, NH); ++h) {
+      for (int w = 0; w < std::min(w_cnt, NW); ++w) {
+        std::copy_n(src + (h * IW + w) * IC, IC, d + (h * NW + w) * IC);
+      }
+    }
+    // B_h^Txd
+    std::fill_n(mid, T * IC, 0.0f);
+    for (int i = 0; i < NH; ++i) {
+      for (int k = 0; k < NH; ++k) {
+        float bt = th.BT[i][k];
+        if (bt == 0.0f) {
+          continue;
+        }
+        for (int w = 0; w < NW; ++w) {
+          for (int c = 0; c < IC; ++c) {
+            mid[(i * NW + w) * IC + c] += bt * d[(k * NW + w) * IC + c];
+          }
+        }
+      }
+    }
+    // B_h^TxdxB_w
+    for (int i = 0; i < NH; ++i) {
+      for (int j = 0; j < NW; ++j) {
+        S* dst_row = dst + (i * NW + j) * dst_step;
+        float* v   = RowBuffer(dst_row, scratch + 2 * T * IC);
+        std::fill_n(v, IC, 0.0f);
+        for (int k = 0; k < NW; ++k) {
+          float bt = tw.BT[j][k];
+          if (bt == 0.0f) {
+            continue;
+          }
+          for (int c = 0; c < IC; ++c) {
+            v[c] += bt * mid[(i * NW + k) * IC + c];
+          }
+        }
+        StoreRow(dst_row, v, IC);
+      }
+    }
+  }
+
+  /**
+   * hadamard:   {tile_cnt, [NH, NW], 4}, for the 4 oc from oc_begin
+   * wino_input: input tile buffer in fp32
+   * weight:     transformed weight in storage type
+   * scratch:    nnz of the 4 oc
+   * */
+  static void HadamardProduct(float* hadamard, const float* wino_input, const WinoSparseWeightT<S>& weight,
+                              int oc_begin, int IC, int tile_cnt, float* scratch) {
+    int block_begin = weight.oc_offset[oc_begin];
+    int block_nnz   = weight.oc_offset[oc_begin + 4] - block_begin;
+    const int* ic_index = weight.ic_index.data() + block_begin;
+    for (int k = 0; k < T; ++k) {
+      const float* w = ConvertToFloat(scratch, weight.value.data() + block_begin * T + k * block_nnz, block_nnz);
+      for (int t = 0; t < tile_cnt; ++t) {
+        const float* v = wino_input + (k * kTileBlock + t) * IC;
+        for (int oc = 0; oc < 4; ++oc) {
+          float temp = 0.0f;
+          int begin  = weight.oc_offset[oc_begin + oc] - block_begin;
+          int end    = weight.oc_offset[oc_begin + oc + 1] - block_begin;
+          for (int idx = begin; idx < end; ++idx) {
+            temp += w[idx] * v[ic_index[idx]];
+          }
+          hadamard[(t * T + k) * 4 + oc] = temp;
+        }
+      }
+    }
+  }
+
+  /**
+   * Y = A_h^T x M x A_w
+   * src:     {[NH, NW], 4}
+   * output:  {h_cnt, w_cnt, oc_cnt}, the step of w is OC
+   * */
+  static void dst_convert(float* output, const float* src, const float* bias, int OW, int OC, int h_cnt,
+                          int w_cnt, int oc_cnt) {
+    const WinogradeTransform<MH, RH>& th = WinogradeTransform<MH, RH>::Get();
+    const WinogradeTransform<MW, RW>& tw = WinogradeTransform<MW, RW>::Get();
+    float mid[MH][NW][4] = {{{0.0f}}};
+    for (int i = 0; i < MH; ++i) {
+      for (int k = 0; k < NH; ++k) {
+        float at = th.AT[i][k];
+        if (at == 0.0f) {
+          continue;
+        }
+        for (int j = 0; j < NW; ++j) {
+          for (int oc = 0; oc < 4; ++oc) {
+            mid[i][j][oc] += at * src[(k * NW + j) * 4 + oc];
+          }
+        }
+      }
+    }
+    for (int i = 0; i < std::min(h_cnt, MH); ++i) {
+      for (int j = 0; j < std::min(w_cnt, MW); ++j) {
+        float temp[4] = {0.0f};
+        for (int k = 0; k < NW; ++k) {
+          float at = tw.AT[j][k];
+          for (int oc = 0; oc < 4; ++oc) {
+            temp[oc] += mid[i][k][oc] * at;
+          }
+        }
+        for (int oc = 0; oc < oc_cnt; ++oc) {
+          output[(i * OW + j) * OC + oc] = temp[oc] + bias[oc];
+        }
+      }
+    }
+  }
+
+  /**
+   * weight:           prepacked by weight_convert
+   * wino_input_cache: the input tile buffer of every tile block is kept for BackwardWeight, can be nullptr
+   *        format: {N, UP_DIV(tile_num, kTileBlock), [NH, NW], kTileBlock, IC}
+   * */
+  static void Forward(float* output, const float* input, const WinoSparseWeightT<S>& weight, const float* bias,
+                      const ConvParam& param, S* wino_input_cache) {
+    int N        = param.N;
+    int IC       = param.IC;
+    int IH       = param.IH;
+    int IW       = param.IW;
+    int OC       = param.OC;
+    int OH       = IH - RH + 1;
+    int OW       = IW - RW + 1;
+    int TH       = UP_DIV(OH, MH);
+    int TW       = UP_DIV(OW, MW);
+    int tile_num = TH * TW;
+
+    int max_block_nnz = 0;
+    for (int oc = 0; oc < OC; oc += 4) {
+      max_block_nnz = std::max(max_block_nnz, weight.oc_offset[oc + 4] - weight.oc_offset[oc]);
+    }
+
+    std::vector<S> wino_input_buffer(T * kTileBlock * IC);
+    // fp32 copy of wino_input_buffer, not used for float storage
+    std::vector<float> wino_input_float(std::is_same<S, float>::value ? 0 : T * kTileBlock * IC);
+    std::vector<float> hadamard_buffer(kTileBlock * T * 4, 0.0f);
+    std::vector<float> scratch(std::max((2 * T + 1) * IC, max_block_nnz), 0.0f);
+    for (int n = 0; n < N; ++n) {
+      const float* input_n = input + n * IH * IW * IC;
+      float* output_n      = output + n * OH * OW * OC;
+      for (int tile_begin = 0; tile_begin < tile_num; tile_begin += kTileBlock) {
+        int tile_cnt = std::min(kTileBlock, tile_num - tile_begin);
+        for (int t = 0; t < tile_cnt; ++t) {
+          int ih = (tile_begin + t) / TW * MH;
+          int iw = (tile_begin + t) % TW * MW;
+          input_convert(wino_input_buffer.data() + t * IC, kTileBlock * IC, input_n + (ih * IW + iw) * IC, IW, IC,
+                        IH - ih, IW - iw, scratch.data());
+        }
+        if (wino_input_cache != nullptr) {
+          size_t block = (size_t)n * UP_DIV(tile_num, kTileBlock) + tile_begin / kTileBlock;
+          S* cache     = wino_input_cache + block * T * kTileBlock * IC;
+          std::copy(wino_input_buffer.begin(), wino_input_buffer.end(), cache);
+        }
+        const float* wino_input =
+            ConvertToFloat(wino_input_float.data(), wino_input_buffer.data(), (int)wino_input_buffer.size());
+        for (int oc = 0; oc < OC; oc += 4) {
+          HadamardProduct(hadamard_buffer.data(), wino_input, weight, oc, IC, tile_cnt, scratch.data());
+          for (int t = 0; t < tile_cnt; ++t) {
+            int oh = (tile_begin + t) / TW * MH;
+            int ow = (tile_begin + t) % TW * MW;
+            dst_convert(output_n + (oh * OW + ow) * OC + oc, hadamard_buffer.data() + t * T * 4, bias + oc, OW, OC,
+                        OH - oh, OW - ow, std::min(4, OC - oc));
+          }
+        }
+      }
+    }
+  }
+
+  // byte of the input cache
+  static size_t InputCacheSize(const ConvParam& param) {
+    int OH        = param.IH - RH + 1;
+    int OW        = param.IW - RW + 1;
+    int block_num = UP_DIV(UP_DIV(OH, MH) * UP_DIV(OW, MW), kTileBlock);
+    return (size_t)param.N * block_num * T * kTileBlock * param.IC * sizeof(S);
+  }
+
+  /**
+   * Z = A_h x dY x A_w^T, the transpose of dst_convert
+   * src:     {h_cnt, w_cnt, OC} of the output grad, out of range is zero
+   * dst:     {[NH, NW], OC}, the step of [NH, NW] is dst_step
+   * */
+  static void grad_convert(float* dst, int dst_step, const float* src, int OW, int OC, int h_cnt, int w_cnt,
+                           float* scratch) {
+    const WinogradeTransform<MH, RH>& th = WinogradeTransform<MH, RH>::Get();
+    const WinogradeTransform<MW, RW>& tw = WinogradeTransform<MW, RW>::Get();
+    // mid: {NH, MW, OC}
+    float* mid = scratch;
+    std::fill_n(mid, NH * MW * OC, 0.0f);
+    for (int i = 0; i < std::min(h_cnt, MH); ++i) {
+      for (int k = 0; k < NH; ++k) {
+        float at = th.AT[i][k];
+        if (at == 0.0f) {
+          continue;
+        }
+        for (int j = 0; j < std::min(w_cnt, MW); ++j) {
+          for (int oc = 0; oc < OC; ++oc) {
+            mid[(k * MW + j) * OC + oc] += at * src[(i * OW + j) * OC + oc];
+          }
+        }
+      }
+    }
+    for (int i = 0; i < NH; ++i) {
+      for (int j = 0; j < NW; ++j) {
+        float* z = dst + (i * NW + j) * dst_step;
+        std::fill_n(z, OC, 0.0f);
+        for (int k = 0; k < MW; ++k) {
+          float at = tw.AT[k][j];
+          if (at == 0.0f) {
+            continue;
+          }
+          for (int oc = 0; oc < OC; ++oc) {
+            z[oc] += at * mid[(i * MW + k) * OC + oc];
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * dg = G_h^T x [sum of (A_h dY A_w^T) hadamard (B_h^T d B_w)] x G_w
+   *
+   * the transformed input tile is read from the cache of Forward, and the product is accumulated
+   * in winograde domain across all tiles and batch, then one inverse transform for every [oc, ic].
+   * accumulate buffer: {[NH, NW], OC, IC}
+   * */
+  static void BackwardWeight(float* weight_grad, float* bias_grad, const float* output_grad,
+                             const S* wino_input_cache, const ConvParam& param) {
+    const WinogradeTransform<MH, RH>& th = WinogradeTransform<MH, RH>::Get();
+    const WinogradeTransform<MW, RW>& tw = WinogradeTransform<MW, RW>::Get();
+    int N         = param.N;
+    int IC        = param.IC;
+    int OC        = param.OC;
+    int OH        = param.IH - RH + 1;
+    int OW        = param.IW - RW + 1;
+    int TW        = UP_DIV(OW, MW);
+    int tile_num  = UP_DIV(OH, MH) * TW;
+    int block_num = UP_DIV(tile_num, kTileBlock);
+
+    std::vector<float> accumulate(T * OC * IC, 0.0f);
+    std::vector<float> wino_grad_buffer(T * kTileBlock * OC, 0.0f);
+    // fp32 copy of the cached tile block, not used for float storage
+    std::vector<float> wino_input_float(std::is_same<S, float>::value ? 0 : T * kTileBlock * IC);
+    std::vector<float> scratch(NH * MW * OC, 0.0f);
+    for (int n = 0; n < N; ++n) {
+      const float* output_grad_n = output_grad + n * OH * OW * OC;
+      for (int block = 0; block < block_num; ++block) {
+        int tile_begin = block * kTileBlock;
+        int tile_cnt   = std::min(kTileBlock, tile_num - tile_begin);
+        for (int t = 0; t < tile_cnt; ++t) {
+          int oh = (tile_begin + t) / TW * MH;
+          int ow = (tile_begin + t) % TW * MW;
+          grad_convert(wino_grad_buffer.data() + t * OC, kTileBlock * OC, output_grad_n + (oh * OW + ow) * OC, OW,
+                       OC, OH - oh, OW - ow, scratch.data());
+        }
+        const S* cache          = wino_input_cache + ((size_t)n * block_num + block) * T * kTileBlock * IC;
+        const float* wino_input = ConvertToFloat(wino_input_float.data(), cache, T * kTileBlock * IC);
+        for (int k = 0; k < T; ++k) {
+          for (int t = 0; t < tile_cnt; ++t) {
+            const float* v = wino_input + (k * kTileBlock + t) * IC;
+            const float* z = wino_grad_buffer.data() + (k * kTileBlock + t) * OC;
+            for (int oc = 0; oc < OC; ++oc) {
+              if (z[oc] == 0.0f) {
+                continue;
+              }
+              float* acc = accumulate.data() + (k * OC + oc) * IC;
+              for (int ic = 0; ic < IC; ++ic) {
+                acc[ic] += z[oc] * v[ic];
+              }
+            }
+          }
+        }
+      }
+    }
+    // G_h^T x acc x G_w
+    for (int oc = 0; oc < OC; ++oc) {
+      for (int ic = 0; ic < IC; ++ic) {
+        float mid[RH][NW] = {{0.0f}};
+        for (int i = 0; i < RH; ++i) {
+          for (int j = 0; j < NW; ++j) {
+            for (int k = 0; k < NH; ++k) {
+              mid[i][j] += th.G[k][i] * accumulate[((k * NW + j) * OC + oc) * IC + ic];
+            }
+          }
+        }
+        for (int i = 0; i < RH; ++i) {
+          for (int j = 0; j < RW; ++j) {
+            float temp = 0.0f;
+            for (int k = 0; k < NW; ++k) {
+              temp += mid[i][k] * tw.G[k][j];
+            }
+            weight_grad[((oc * IC + ic) * RH + i) * RW + j] = temp;
+          }
+        }
+      }
+    }
+    if (bias_grad != nullptr) {
+      std::fill_n(bias_grad, OC, 0.0f);
+      for (int i = 0; i < N * OH * OW; ++i) {
+        for (int oc = 0; oc < OC; ++oc) {
+          bias_grad[oc] += output_grad[i * OC + oc];
+        }
+      }
+    }
+  }
+};
+
+template <int MH, int RH, int MW, int RW, class S>
+const int WinogradeFmr<MH, RH, MW, RW, S>::NH;
+template <int MH, int RH, int MW, int RW, class S>
+const int WinogradeFmr<MH, RH, MW, RW, S>::NW;
+template <int MH, int RH, int MW, int RW, class S>
+const int WinogradeFmr<MH, RH, MW, RW, S>::T;
+
+bool WinogradeSupport(int KH, int KW) {
+  if (KH == KW) {
+    return KH == 3 || KH == 5;
+  }
+  int K = std::max(KH, KW);
+  return std::min(KH, KW) == 1 && (K == 3 || K == 5 || K == 7);
+}
+
+/**
+ * call OP::Run<WinogradeFmr<MH, RH, MW, RW, S>>() with the F(m, r) of the kernel size
+ * */
+template <class OP, int MH, int RH, int MW, int RW>
+static bool WinogradeDispatch(DataType storage_type, OP& op) {
+  if (storage_type == DATA_TYPE_FLOAT) {
+    op.template Run<WinogradeFmr<MH, RH, MW, RW, float>>();
+  } else if (storage_type == DATA_TYPE_HALF) {
+    op.template Run<WinogradeFmr<MH, RH, MW, RW, fp16_t>>();
+  } else if (storage_type == DATA_TYPE_BFP16) {
+    op.template Run<WinogradeFmr<MH, RH, MW, RW, bfp16_t>>();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * the weight must not be empty
+ * */
+static bool WinogradeValidWeight(const ConvParam& param) {
+  return param.IC > 0 && param.OC > 0 && param.KH > 0 && param.KW > 0;
+}
+
+/**
+ * the output must not be empty
+ * */
+static bool WinogradeValidParam(const ConvParam& param) {
+  return WinogradeValidWeight(param) && param.N > 0 && param.IH >= param.KH && param.IW >= param.KW;
+}
+
+/**
+ * the WinoSparseWeightT of the storage type in WinogradeWeight
+ * */
+static WinoSparseWeightT<float>* StorageWeight(WinogradeWeight* weight, float*) {
+  return &weight->fp32;
+}
+
+static WinoSparseWeightT<fp16_t>* StorageWeight(WinogradeWeight* weight, fp16_t*) {
+  return &weight->fp16;
+}
+
+static WinoSparseWeightT<bfp16_t>* StorageWeight(WinogradeWeight* weight, bfp16_t*) {
+  return &weight->bfp16;
+}
+
+static const WinoSparseWeightT<float>& StorageWeight(const WinogradeWeight& weight, float*) {
+  return weight.fp32;
+}
+
+static const WinoSparseWeightT<fp16_t>& StorageWeight(const WinogradeWeight& weight, fp16_t*) {
+  return weight.fp16;
+}
+
+static const WinoSparseWeightT<bfp16_t>& StorageWeight(const WinogradeWeight& weight, bfp16_t*) {
+  return weight.bfp16;
+}
+
+template <class OP>
+static bool WinogradeDispatch(const ConvParam& param, OP& op) {
+  int KH = param.KH;
+  int KW = param.KW;
+  if (KH == 3 && KW == 3) {
+    return WinogradeDispatch<OP, 2, 3, 2, 3>(param.storage_type, op);
+  } else if (KH == 5 && KW == 5) {
+    return WinogradeDispatch<OP, 2, 5, 2, 5>(param.storage_type, op);
+  } else if (KH == 1 && KW == 3) {
+    return WinogradeDispatch<OP, 1, 1, 4, 3>(param.storage_type, op);
+  } else if (KH == 3 && KW == 1) {
+    return WinogradeDispatch<OP, 4, 3, 1, 1>(param.storage_type, op);
+  } else if (KH == 1 && KW == 5) {
+    return WinogradeDispatch<OP, 1, 1, 4, 5>(param.storage_type, op);
+  } else if (KH == 5 && KW == 1) {
+    return WinogradeDispatch<OP, 4, 5, 1, 1>(param.storage_type, op);
+  } else if (KH == 1 && KW == 7) {
+    return WinogradeDispatch<OP, 1, 1, 2, 7>(param.storage_type, op);
+  } else if (KH == 7 && KW == 1) {
+    return WinogradeDispatch<OP, 2, 7, 1, 1>(param.storage_type, op);
+  }
+  return false;
+}
+
+struct PrepackWeightOp {
+  WinogradeWeight* packed;
+  const float* weight;
+  const ConvParam& param;
+  template <class WINO>
+  void Run() {
+    WINO::weight_convert(StorageWeight(packed, (typename WINO::storage_t*)nullptr), weight, param.OC, param.IC);
+  }
+};
+
+struct ForwardOp {
+  float* output;
+  const float* input;
+  const WinogradeWeight& weight;
+  const float* bias;
+  const ConvParam& param;
+  void* wino_input_cache;
+  template <class WINO>
+  void Run() {
+    typedef typename WINO::storage_t S;
+    WINO::Forward(output, input, StorageWeight(weight, (S*)nullptr), bias, param, (S*)wino_input_cache);
+  }
+};
+
+struct InputCacheSizeOp {
+  const ConvParam& param;
+  size_t size;
+  template <class WINO>
+  void Run() {
+    size = WINO::InputCacheSize(param);
+  }
+};
+
+struct BackwardWeightOp {
+  float* weight_grad;
+  float* bias_grad;
+  const float* output_grad;
+  const void* wino_input_cache;
+  const ConvParam& param;
+  template <class WINO>
+  void Run() {
+    WINO::BackwardWeight(weight_grad, bias_grad, output_grad, (const typename WINO::storage_t*)wino_input_cache,
+                         param);
+  }
+};
+
+bool WinogradePrepackWeight(WinogradeWeight* packed, const float* weight, const ConvParam& param) {
+  if (!WinogradeValidWeight(param)) {
+    return false;
+  }
+  *packed       = WinogradeWeight();
+  packed->param = param;
+  PrepackWeightOp op = {packed, weight, param};
+  return WinogradeDispatch(param, op);
+}
+
+bool WinogradeNHWCFmr(float* output, const float* input, const WinogradeWeight& weight, const float* bias,
+                      const ConvParam& param, void* wino_input_cache) {
+  const ConvParam& packed = weight.param;
+  if (!WinogradeValidParam(param) || packed.IC != param.IC || packed.OC != param.OC || packed.KH != param.KH ||
+      packed.KW != param.KW || packed.storage_type != param.storage_type) {
+    return false;
+  }
+  ForwardOp op = {output, input, weight, bias, param, wino_input_cache};
+  return WinogradeDispatch(param, op);
+}
+
+bool WinogradeNHWCFmr(float* output, const float* input, const float* weight, const float* bias,
+                      const ConvParam& param, void* wino_input_cache) {
+  WinogradeWeight packed;
+  if (!WinogradeValidParam(param) || !WinogradePrepackWeight(&packed, weight, param)) {
+    return false;
+  }
+  return WinogradeNHWCFmr(output, input, packed, bias, param, wino_input_cache);
+}
+
+size_t WinogradeInputCacheSize(const ConvParam& param) {
+  if (!WinogradeValidParam(param)) {
+    return 0;
+  }
+  InputCacheSizeOp op = {param, 0};
+  return WinogradeDispatch(param, op) ? op.size : 0;
+}
+
+/**
+ * dX = full correlation of dY and the rotated weight, OC and IC is transposed
+ *      weight':    {IC, OC, KH, KW}, weight'[ic][oc][i][j] = weight[oc][ic][KH-1-i][KW-1-j]
+ *      dY':        dY with KH-1, KW-1 zero pad
+ * */
+bool WinogradePrepackBackwardDataWeight(WinogradeWeight* packed, const float* weight, const ConvParam& param) {
+  if (!WinogradeValidWeight(param)) {
+    return false;
+  }
+  int IC = param.IC;
+  int OC = param.OC;
+  int KH = param.KH;
+  int KW = param.KW;
+  std::vector<float> rotate_weight(IC * OC * KH * KW, 0.0f);
+  for (int oc = 0; oc < OC; ++oc) {
+    for (int ic = 0; ic < IC; ++ic) {
+      for (int i = 0; i < KH; ++i) {
+        for (int j = 0; j < KW; ++j) {
+          rotate_weight[((ic * OC + oc) * KH + KH - 1 - i) * KW + KW - 1 - j] =
+              weight[((oc * IC + ic) * KH + i) * KW + j];
+        }
+      }
+    }
+  }
+  ConvParam grad_param = {param.N, OC, param.IH, param.IW, IC, KH, KW, param.storage_type};
+  return WinogradePrepackWeight(packed, rotate_weight.data(), grad_param);
+}
+
+bool WinogradeBackwardData(float* input_grad, const float* output_grad, const WinogradeWeight& weight,
+                           const ConvParam& param) {
+  if (!WinogradeValidParam(param) || !WinogradeSupport(param.KH, param.KW)) {
+    return false;
+  }
+  int N  = param.N;
+  int IC = param.IC;
+  int OC = param.OC;
+  int KH = param.KH;
+  int KW = param.KW;
+  int OH = param.IH - KH + 1;
+  int OW = param.IW - KW + 1;
+  int PH = OH + 2 * (KH - 1);
+  int PW = OW + 2 * (KW - 1);
+  std::vector<float> pad_grad(N * PH * PW * OC, 0.0f);
+  for (int n = 0; n < N; ++n) {
+    for (int oh = 0; oh < OH; ++oh) {
+      std::copy_n(output_grad + (n * OH + oh) * OW * OC, OW * OC,
+                  pad_grad.data() + ((n * PH + oh + KH - 1) * PW + KW - 1) * OC);
+    }
+  }
+  std::vector<float> zero_bias(IC, 0.0f);
+  ConvParam grad_param = {N, OC, PH, PW, IC, KH, KW, param.storage_type};
+  return WinogradeNHWCFmr(input_grad, pad_grad.data(), weight, zero_bias.data(), grad_param);
+}
+
+bool WinogradeBackwardData(float* input_grad, const float* output_grad, const float* weight,
+                           const ConvParam& param) {
+  WinogradeWeight packed;
+  if (!WinogradeValidParam(param) || !WinogradePrepackBackwardDataWeight(&packed, weight, param)) {
+    return false;
+  }
+  return WinogradeBackwardData(input_grad, output_grad, packed, param);
+}
+
+bool WinogradeBackwardWeight(float* weight_grad, float* bias_grad, const float* output_grad,
+                             const void* wino_input_cache, const ConvParam& param) {
+  if (wino_input_cache == nullptr || !WinogradeValidParam(param)) {
+    return false;
+  }
+  BackwardWeightOp op = {weight_grad, bias_grad, output_grad, wino_input_cache, param};
+  return WinogradeDispatch(param, op);
+}
+
+bool Winograde1DNWC(float* output, const float* input, const float* weight, const float* bias, int N, int IC,
+                    int IW, int OC, int K) {
+  ConvParam param = {N, IC, 1, IW, OC, 1, K, DATA_TYPE_FLOAT};
+  return WinogradeNHWCFmr(output, input, weight, bias, param);
+}
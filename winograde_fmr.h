@@ -0,0 +1,171 @@
+// Tencent is pleased to support the open source community by making TNN available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef WINOGRADECONV_WINOGRADE_FMR_H
+#define WINOGRADECONV_WINOGRADE_FMR_H
+
+#include <cstddef>
+
+#include "winograde_c4.h"
+#include "winograde_half.h"
+
+/**
+ * stride = 1, dilation = 1, group = 1
+ *
+ * input:   {N, IH, IW, IC}, already padded
+ * weight:  {OC, IC, KH, KW}
+ * bias:    {OC}
+ * output:  {N, OH, OW, OC}, OH = IH - KH + 1, OW = IW - KW + 1
+ *
+ * storage_type: type of the transformed weight and input tile, DATA_TYPE_HALF and DATA_TYPE_BFP16 halve the
+ *               memory traffic, the hadamard product and transform are still fp32
+ * */
+struct ConvParam {
+  int N;
+  int IC;
+  int IH;
+  int IW;
+  int OC;
+  int KH;
+  int KW;
+  DataType storage_type;
+};
+
+/**
+ * Cook-Toom transform matrix of F(m, r), n = m + r - 1
+ *
+ * points: 0, 1, -1, 2, -2, 1/2, -1/2, ..., infinity
+ *
+ *  Y   = A^T[(Gg) hadamard (B^Td)]
+ *  A^T = (m, n)
+ *  G   = (n, r)
+ *  B^T = (n, n)
+ * */
+void CookToom(int m, int r, float* AT, float* G, float* BT);
+
+template <int M, int R>
+struct WinogradeTransform {
+  static const int N = M + R - 1;
+  float AT[M][N];
+  float G[N][R];
+  float BT[N][N];
+
+  // generated once for every F(m, r)
+  static const WinogradeTransform& Get() {
+    static const WinogradeTransform transform;
+    return transform;
+  }
+
+ private:
+  WinogradeTransform() {
+    CookToom(M, R, &AT[0][0], &G[0][0], &BT[0][0]);
+  }
+};
+
+template <int M, int R>
+const int WinogradeTransform<M, R>::N;
+
+/**
+ * F(mh x mw, kh x kw), separable 2D transform, kh = 1 or kw = 1 is the 1D transform
+ *
+ *  3x3:        F(2x2, 3x3)
+ *  5x5:        F(2x2, 5x5)
+ *  1x3, 3x1:   F(1x4, 1x3), F(4x1, 3x1)
+ *  1x5, 5x1:   F(1x4, 1x5), F(4x1, 5x1)
+ *  1x7, 7x1:   F(1x2, 1x7), F(2x1, 7x1)
+ * */
+bool WinogradeSupport(int KH, int KW);
+
+/**
+ * transformed weight, prepacked once and reused by every call with the same IC, OC, KH, KW and storage_type
+ *
+ * param:   the param it is packed for, N, IH and IW are not used
+ * only the WinoSparseWeightT of param.storage_type is filled, its value is in that type
+ * */
+struct WinogradeWeight {
+  ConvParam param;
+  WinoSparseWeightT<float> fp32;
+  WinoSparseWeightT<fp16_t> fp16;
+  WinoSparseWeightT<bfp16_t> bfp16;
+};
+
+/**
+ * weight:  {OC, IC, KH, KW}
+ * return false if the kernel size is not supported, or IC, OC, KH or KW <= 0
+ * */
+bool WinogradePrepackWeight(WinogradeWeight* packed, const float* weight, const ConvParam& param);
+
+/**
+ * return false if the kernel size is not supported, or the shape is invalid:
+ * N, IC or OC <= 0, IH < KH, IW < KW, or the weight is not packed for the IC, OC, KH, KW and storage_type of param
+ *
+ * wino_input_cache: keep the transformed input tile for WinogradeBackwardWeight, can be nullptr,
+ *                   stored in storage_type, WinogradeInputCacheSize(param) byte
+ * */
+bool WinogradeNHWCFmr(float* output, const float* input, const WinogradeWeight& weight, const float* bias,
+                      const ConvParam& param, void* wino_input_cache = nullptr);
+
+/**
+ * prepack the weight for this call only
+ * */
+bool WinogradeNHWCFmr(float* output, const float* input, const float* weight, const float* bias,
+                      const ConvParam& param, void* wino_input_cache = nullptr);
+
+/**
+ * byte of wino_input_cache, 0 if the param is not supported
+ * */
+size_t WinogradeInputCacheSize(const ConvParam& param);
+
+/**
+ * the weight of WinogradeBackwardData, rotated and with OC, IC transposed
+ * param is the param of the forward conv, return false like WinogradePrepackWeight
+ * */
+bool WinogradePrepackBackwardDataWeight(WinogradeWeight* packed, const float* weight, const ConvParam& param);
+
+/**
+ * param is the param of the forward conv, return false like WinogradeNHWCFmr
+ *
+ * output_grad: {N, OH, OW, OC}
+ * input_grad:  {N, IH, IW, IC}, grad of the padded input
+ * weight:      from WinogradePrepackBackwardDataWeight of the same param
+ * */
+bool WinogradeBackwardData(float* input_grad, const float* output_grad, const WinogradeWeight& weight,
+                           const ConvParam& param);
+
+/**
+ * prepack the weight for this call only
+ * */
+bool WinogradeBackwardData(float* input_grad, const float* output_grad, const float* weight,
+                           const ConvParam& param);
+
+/**
+ * wino_input_cache:    filled by WinogradeNHWCFmr of the same param, storage_type included, the tile is read
+ *                      in that storage type
+ * weight_grad:         {OC, IC, KH, KW}
+ * bias_grad:           {OC}, can be nullptr
+ *
+ * return false like WinogradeNHWCFmr, or if wino_input_cache is nullptr
+ * */
+bool WinogradeBackwardWeight(float* weight_grad, float* bias_grad, const float* output_grad,
+                             const void* wino_input_cache, const ConvParam& param);
+
+/**
+ * input:   {N, IW, IC}, already padded
+ * weight:  {OC, IC, K}
+ * output:  {N, IW - K + 1, OC}
+ * */
+bool Winograde1DNWC(float* output, const float* input, const float* weight, const float* bias, int N, int IC,
+                    int IW, int OC, int K);
+
+#endif  // WINOGRADECONV_WINOGRADE_FMR_H
@@ -0,0 +1,155 @@
+// Tencent is pleased to support the open source community by making TNN available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "winograde_half.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WINOGRADE_X86_DISPATCH
+#endif
+
+#ifdef WINOGRADE_X86_DISPATCH
+/**
+ * the instruction set is checked at runtime, the build does not need -march
+ * */
+static bool CpuSupportF16C() {
+  static const bool support = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return support;
+}
+
+static bool CpuSupportAVX2() {
+  static const bool support = __builtin_cpu_supports("avx2");
+  return support;
+}
+
+static bool CpuSupportAVX512BF16() {
+  static const bool support = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bf16");
+  return support;
+}
+
+__attribute__((target("avx,f16c"))) static int Float32ToFloat16F16C(fp16_t* dst, const float* src, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), h);
+  }
+  return i;
+}
+
+__attribute__((target("avx,f16c"))) static int Float16ToFloat32F16C(float* dst, const fp16_t* src, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+  }
+  return i;
+}
+
+/**
+ * VCVTNEPS2BF16 rounds to nearest even like Float32ToBFloat16, fp32 subnormal input is flushed to zero
+ * */
+__attribute__((target("avx512f,avx512bf16"))) static int Float32ToBFloat16AVX512(bfp16_t* dst, const float* src,
+                                                                                  int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), (__m256i)h);
+  }
+  return i;
+}
+
+/**
+ * the integer rounding of Float32ToBFloat16, 8 at a time
+ * */
+__attribute__((target("avx2"))) static int Float32ToBFloat16AVX2(bfp16_t* dst, const float* src, int count) {
+  const __m256i one      = _mm256_set1_epi32(1);
+  const __m256i bias     = _mm256_set1_epi32(0x7fff);
+  const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+  const __m256i inf      = _mm256_set1_epi32(0x7f800000);
+  const __m256i quiet    = _mm256_set1_epi32(0x40);
+  int i                  = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i x       = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i lsb     = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+    __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(x, bias), lsb), 16);
+    __m256i nan     = _mm256_or_si256(_mm256_srli_epi32(x, 16), quiet);
+    __m256i is_nan  = _mm256_cmpgt_epi32(_mm256_and_si256(x, abs_mask), inf);
+    __m256i h       = _mm256_blendv_epi8(rounded, nan, is_nan);
+    // {0..3, 0..3 | 4..7, 4..7} --> {0..7}
+    h = _mm256_permute4x64_epi64(_mm256_packus_epi32(h, h), 0x08);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(h));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static int BFloat16ToFloat32AVX2(float* dst, const bfp16_t* src, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_slli_epi32(x, 16));
+  }
+  return i;
+}
+#endif
+
+void ConvertFromFloat(fp16_t* dst, const float* src, int count) {
+  int i = 0;
+#ifdef WINOGRADE_X86_DISPATCH
+  if (CpuSupportF16C()) {
+    i = Float32ToFloat16F16C(dst, src, count);
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i].bits = Float32ToFloat16(src[i]);
+  }
+}
+
+void ConvertFromFloat(bfp16_t* dst, const float* src, int count) {
+  int i = 0;
+#ifdef WINOGRADE_X86_DISPATCH
+  if (CpuSupportAVX512BF16()) {
+    i = Float32ToBFloat16AVX512(dst, src, count);
+  } else if (CpuSupportAVX2()) {
+    i = Float32ToBFloat16AVX2(dst, src, count);
+  }
+#endif
+  for (; i < count; ++i) {
+    dst[i].bits = Float32ToBFloat16(src[i]);
+  }
+}
+
+const float* ConvertToFloat(float* scratch, const fp16_t* src, int count) {
+  int i = 0;
+#ifdef WINOGRADE_X86_DISPATCH
+  if (CpuSupportF16C()) {
+    i = Float16ToFloat32F16C(scratch, src, count);
+  }
+#endif
+  for (; i < count; ++i) {
+    scratch[i] = Float16ToFloat32(src[i].bits);
+  }
+  return scratch;
+}
+
+const float* ConvertToFloat(float* scratch, const bfp16_t* src, int count) {
+  int i = 0;
+#ifdef WINOGRADE_X86_DISPATCH
+  if (CpuSupportAVX2()) {
+    i = BFloat16ToFloat32AVX2(scratch, src, count);
+  }
+#endif
+  for (; i < count; ++i) {
+    scratch[i] = BFloat16ToFloat32(src[i].bits);
+  }
+  return scratch;
+}
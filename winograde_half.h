@@ -0,0 +1,123 @@
+// Tencent is pleased to support the open source community by making TNN available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef WINOGRADECONV_WINOGRADE_HALF_H
+#define WINOGRADECONV_WINOGRADE_HALF_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * storage type of the transformed weight and input tile, compute is always fp32
+ * */
+enum DataType { DATA_TYPE_FLOAT = 0, DATA_TYPE_HALF = 1, DATA_TYPE_BFP16 = 2 };
+
+struct fp16_t {
+  uint16_t bits;
+};
+
+struct bfp16_t {
+  uint16_t bits;
+};
+
+/**
+ * software fallback, round to nearest even
+ * */
+inline uint16_t Float32ToFloat16(float value) {
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t abs  = x & 0x7fffffff;
+  if (abs >= 0x7f800000) {
+    // inf, nan
+    return (uint16_t)(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+  }
+  if (abs >= 0x477ff000) {
+    // >= 65520 is rounded to inf
+    return (uint16_t)(sign | 0x7c00);
+  }
+  if (abs < 0x38800000) {
+    // < 2^-14, subnormal of fp16, x * 2^24 is exact
+    float f;
+    memcpy(&f, &abs, sizeof(f));
+    return (uint16_t)(sign | (uint32_t)std::nearbyint(f * 16777216.0f));
+  }
+  // rebias exponent from 127 to 15
+  uint32_t e = abs - 0x38000000;
+  return (uint16_t)(sign | ((e + 0xfff + ((e >> 13) & 1)) >> 13));
+}
+
+inline float Float16ToFloat32(uint16_t value) {
+  uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+  uint32_t exp  = (value >> 10) & 0x1f;
+  uint32_t mant = value & 0x3ff;
+  uint32_t x;
+  if (exp == 0) {
+    float f = (float)mant * (1.0f / 16777216.0f);
+    memcpy(&x, &f, sizeof(x));
+    x |= sign;
+  } else if (exp == 0x1f) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else {
+    x = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float f;
+  memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+inline uint16_t Float32ToBFloat16(float value) {
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+  if ((x & 0x7fffffff) > 0x7f800000) {
+    // quiet nan
+    return (uint16_t)((x >> 16) | 0x40);
+  }
+  return (uint16_t)((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+inline float BFloat16ToFloat32(uint16_t value) {
+  uint32_t x = (uint32_t)value << 16;
+  float f;
+  memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+/**
+ * fp32 <--> storage type, F16C, AVX2 and AVX512-BF16 are selected at runtime when the cpu has them,
+ * the software convert above is the fallback, see winograde_half.cpp
+ * */
+inline void ConvertFromFloat(float* dst, const float* src, int count) {
+  memcpy(dst, src, count * sizeof(float));
+}
+
+void ConvertFromFloat(fp16_t* dst, const float* src, int count);
+
+void ConvertFromFloat(bfp16_t* dst, const float* src, int count);
+
+/**
+ * return src directly for fp32, or the converted data in scratch
+ * */
+inline const float* ConvertToFloat(float* scratch, const float* src, int count) {
+  (void)scratch;
+  (void)count;
+  return src;
+}
+
+const float* ConvertToFloat(float* scratch, const fp16_t* src, int count);
+
+const float* ConvertToFloat(float* scratch, const bfp16_t* src, int count);
+
+#endif  // WINOGRADECONV_WINOGRADE_HALF_H